@@ -1,20 +1,41 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 #include <unistd.h>
 #include <arpa/inet.h>
 #include <sys/socket.h>
 #include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/un.h>
 #include <netinet/in.h>
 #include <fcntl.h>
+#include <errno.h>
 #include <time.h>
 
 #define MAX_BUFFER_SIZE 1024
 #define MAX_USERS 100
-#define MAX_CACHED_MSGS 50
 #define VIEW_LENGTH 3
 #define SWAP_LENGTH 2
 #define FORWARD_COUNT 2
+#define NET_READS_PER_WAKEUP 64     // Datagrams drained from srvsock per select()
+#define NET_RECV_BUFFER (4 << 20)   // Requested UDP receive buffer, in bytes
+
+// Seen-message cache: a message is remembered for SEEN_WINDOW seconds.
+// SEEN_SETS * SEEN_WAYS entries cover roughly 5,000 messages per second.
+#define SEEN_WINDOW 30
+#define SEEN_SETS (1 << 15)
+#define SEEN_WAYS 16
+
+// Local publish/subscribe endpoint
+#define MAX_IPC_CLIENTS 8
+#define MAX_IPC_PACKET 65536
+#define IPC_QUEUE_LENGTH 128    // Deliveries buffered per subscriber
+#define IPC_MAX_BATCH 32        // Messages accepted per PUB request
+#define IPC_HIGH_WATERMARK (IPC_QUEUE_LENGTH - IPC_MAX_BATCH)
+#define IPC_READS_PER_WAKEUP 16 // Requests drained per client per select()
+#define IPC_STALL_TIMEOUT 5     // Seconds a subscriber may stay backed up
+#define IPC_REPLY_QUEUE 4       // Unsent replies buffered per client
 
 typedef struct {
     char id[50];
@@ -28,6 +49,40 @@ typedef struct {
     int count;             // Current number of descriptors in view
 } View;
 
+typedef struct {
+    uint64_t hash;
+    time_t seen;           // 0 when the entry is free
+} SeenEntry;
+
+typedef struct {
+    SeenEntry sets[SEEN_SETS][SEEN_WAYS];
+} SeenCache;
+
+typedef struct {
+    int fd;                // -1 when the slot is free
+    int subscribed;        // Set once the client has sent SUB
+    char queue[IPC_QUEUE_LENGTH][MAX_BUFFER_SIZE];
+    int head;              // Index of the oldest queued delivery
+    int count;             // Number of queued deliveries
+    int dropped;           // Deliveries discarded since the last DROPPED notice
+    time_t stalled_since;  // When the queue went above the high watermark, or 0
+    int held;              // Set while a PUB waits for subscribers to drain
+    char replies[IPC_REPLY_QUEUE][MAX_BUFFER_SIZE];
+    int reply_head;        // Index of the oldest unsent reply
+    int reply_count;       // Number of unsent replies
+} IpcClient;
+
+// Node state shared between stdin and local IPC requests
+typedef struct {
+    int srvsock;
+    NodeDescriptor *self;
+    View *view;
+    SeenCache *seen;
+    time_t *last_cycle_time;
+    IpcClient *clients;
+    unsigned int next_seq; // Sequence number for the next originated message
+} NodeContext;
+
 void error(const char *msg) {
     perror(msg);
     exit(EXIT_FAILURE);
@@ -154,42 +209,425 @@ int select_random_descriptors(View *view, NodeDescriptor *selected, int count) {
     return selected_count;
 }
 
-// Check if a message has been seen before
-int is_duplicate_message(char *msg, char cached_msgs[][MAX_BUFFER_SIZE], int *msg_count) {
-    for (int i = 0; i < *msg_count; i++) {
-        if (strcmp(msg, cached_msgs[i]) == 0) {
+// 64-bit FNV-1a hash of a message
+uint64_t hash_message(const char *msg) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (const unsigned char *p = (const unsigned char *)msg; *p; p++) {
+        hash ^= *p;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Check if a message has been seen within the last SEEN_WINDOW seconds.
+// Messages are keyed by hash; each set evicts its oldest entry when full.
+int is_duplicate_message(const char *msg, SeenCache *cache) {
+    uint64_t hash = hash_message(msg);
+    SeenEntry *set = cache->sets[hash & (SEEN_SETS - 1)];
+    time_t now = time(NULL);
+    int victim = 0;
+
+    for (int i = 0; i < SEEN_WAYS; i++) {
+        if (set[i].seen != 0 && now - set[i].seen < SEEN_WINDOW && set[i].hash == hash) {
             return 1;
         }
+        if (set[i].seen < set[victim].seen) {
+            victim = i;
+        }
     }
 
     // Add to cache if not found
-    if (*msg_count < MAX_CACHED_MSGS) {
-        strcpy(cached_msgs[*msg_count], msg);
-        (*msg_count)++;
-    } else {
-        // Replace oldest message (simple FIFO)
-        for (int i = 0; i < MAX_CACHED_MSGS - 1; i++) {
-            strcpy(cached_msgs[i], cached_msgs[i+1]);
+    set[victim].hash = hash;
+    set[victim].seen = now;
+    return 0;
+}
+
+// Send a message to up to FORWARD_COUNT random peers from the view
+void send_to_random_peers(int srvsock, View *view, const char *msg, int forwarding) {
+    if (view->count == 0) {
+        printf(forwarding ? "→ No peers in view to forward message to\n"
+                          : "→ No peers in view to send message to\n");
+        return;
+    }
+
+    // Shuffle view indices for random selection
+    int indices[VIEW_LENGTH];
+    for (int i = 0; i < view->count; i++) {
+        indices[i] = i;
+    }
+
+    // Fisher-Yates shuffle
+    for (int i = view->count - 1; i > 0; i--) {
+        int j = rand() % (i + 1);
+        int temp = indices[i];
+        indices[i] = indices[j];
+        indices[j] = temp;
+    }
+
+    // Select up to FORWARD_COUNT peers
+    int send_to = (view->count < FORWARD_COUNT) ? view->count : FORWARD_COUNT;
+
+    struct sockaddr_in peeraddr;
+    printf(forwarding ? "→ Forwarding to peers:\n" : "→ Sending to peers:\n");
+
+    for (int i = 0; i < send_to; i++) {
+        NodeDescriptor *peer = &view->descriptors[indices[i]];
+
+        memset(&peeraddr, 0, sizeof(peeraddr));
+        peeraddr.sin_family = AF_INET;
+        peeraddr.sin_port = htons(peer->port);
+        inet_pton(AF_INET, peer->ipaddr, &peeraddr.sin_addr);
+
+        printf("   → Peer: %s (%s:%d)\n", peer->id, peer->ipaddr, peer->port);
+
+        sendto(srvsock, msg, strlen(msg), 0,
+            (struct sockaddr *)&peeraddr, sizeof(peeraddr));
+    }
+}
+
+// Open the local publish/subscribe endpoint. SOCK_SEQPACKET keeps every
+// request and every delivery as one packet on a reliable connection.
+int open_ipc_socket(const char *path) {
+    struct sockaddr_un addr;
+
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        fprintf(stderr, "IPC socket path too long: %s\n", path);
+        exit(EXIT_FAILURE);
+    }
+
+    int sock = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+    if (sock < 0) error("ERROR opening IPC socket");
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+
+    // Remove a stale socket left behind by a previous run, but never
+    // anything else that happens to live at that path
+    struct stat st;
+    if (lstat(path, &st) == 0) {
+        if (!S_ISSOCK(st.st_mode)) {
+            fprintf(stderr, "Refusing to replace non-socket file: %s\n", path);
+            exit(EXIT_FAILURE);
+        }
+        unlink(path);
+    }
+
+    if (bind(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
+        error("ERROR on binding IPC socket");
+    }
+    if (listen(sock, MAX_IPC_CLIENTS) < 0) error("ERROR on IPC listen");
+
+    return sock;
+}
+
+// Queue a reply for the client; it is sent by ipc_flush_client. Requests
+// are only read while the reply queue has room, so replies are never lost.
+void ipc_reply(IpcClient *client, const char *msg) {
+    if (client->reply_count == IPC_REPLY_QUEUE) return;
+
+    int tail = (client->reply_head + client->reply_count) % IPC_REPLY_QUEUE;
+    snprintf(client->replies[tail], MAX_BUFFER_SIZE, "%s", msg);
+    client->reply_count++;
+}
+
+// Accept a new local client into a free slot
+void ipc_accept_client(int ipcsock, IpcClient clients[]) {
+    int fd = accept(ipcsock, NULL, NULL);
+    if (fd < 0) return;
+
+    for (int i = 0; i < MAX_IPC_CLIENTS; i++) {
+        if (clients[i].fd < 0) {
+            clients[i].fd = fd;
+            clients[i].subscribed = 0;
+            clients[i].head = 0;
+            clients[i].count = 0;
+            clients[i].dropped = 0;
+            clients[i].stalled_since = 0;
+            clients[i].held = 0;
+            clients[i].reply_head = 0;
+            clients[i].reply_count = 0;
+            printf("\n[IPC] Client %d connected\n", i);
+            return;
+        }
+    }
+
+    const char *busy = "ERROR too many clients";
+    send(fd, busy, strlen(busy), MSG_DONTWAIT | MSG_NOSIGNAL);
+    close(fd);
+}
+
+void ipc_close_client(IpcClient *client) {
+    close(client->fd);
+    client->fd = -1;
+    client->subscribed = 0;
+    client->count = 0;
+    client->dropped = 0;
+    client->stalled_since = 0;
+    client->held = 0;
+    client->reply_count = 0;
+}
+
+// Queue a delivered message for every subscriber. A subscriber whose queue
+// is full loses its oldest delivery and is told so with a DROPPED notice.
+void ipc_deliver(IpcClient clients[], const char *msg) {
+    for (int i = 0; i < MAX_IPC_CLIENTS; i++) {
+        IpcClient *client = &clients[i];
+        if (client->fd < 0 || !client->subscribed) continue;
+
+        if (client->count == IPC_QUEUE_LENGTH) {
+            client->head = (client->head + 1) % IPC_QUEUE_LENGTH;
+            client->count--;
+            client->dropped++;
+        }
+
+        int tail = (client->head + client->count) % IPC_QUEUE_LENGTH;
+        snprintf(client->queue[tail], MAX_BUFFER_SIZE, "%s", msg);
+        client->count++;
+
+        if (client->count > IPC_HIGH_WATERMARK && client->stalled_since == 0) {
+            client->stalled_since = time(NULL);
+        }
+    }
+}
+
+// Write queued replies, then deliveries, until both queues are empty or the
+// socket is full. Returns -1 if the client has gone away.
+int ipc_flush_client(IpcClient *client) {
+    char packet[MAX_BUFFER_SIZE + 16];
+
+    while (client->reply_count > 0) {
+        const char *reply = client->replies[client->reply_head];
+        if (send(client->fd, reply, strlen(reply), MSG_DONTWAIT | MSG_NOSIGNAL) < 0) {
+            return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+        }
+        client->reply_head = (client->reply_head + 1) % IPC_REPLY_QUEUE;
+        client->reply_count--;
+    }
+
+    if (client->dropped > 0) {
+        int len = snprintf(packet, sizeof(packet), "DROPPED %d", client->dropped);
+        if (send(client->fd, packet, len, MSG_DONTWAIT | MSG_NOSIGNAL) < 0) {
+            return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+        }
+        client->dropped = 0;
+    }
+
+    while (client->count > 0) {
+        int len = snprintf(packet, sizeof(packet), "MSG %s", client->queue[client->head]);
+        if (send(client->fd, packet, len, MSG_DONTWAIT | MSG_NOSIGNAL) < 0) {
+            return (errno == EAGAIN || errno == EWOULDBLOCK) ? 0 : -1;
+        }
+        client->head = (client->head + 1) % IPC_QUEUE_LENGTH;
+        client->count--;
+    }
+
+    if (client->count <= IPC_HIGH_WATERMARK) {
+        client->stalled_since = 0;
+    }
+    return 0;
+}
+
+// PUB requests are only read while every subscriber can take a full batch,
+// so slow subscribers push back on publishers through the socket buffers
+int ipc_subscribers_have_room(IpcClient clients[]) {
+    for (int i = 0; i < MAX_IPC_CLIENTS; i++) {
+        if (clients[i].fd >= 0 && clients[i].subscribed &&
+            clients[i].count > IPC_HIGH_WATERMARK) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Disconnect subscribers that have stayed above the high watermark for
+// IPC_STALL_TIMEOUT seconds, so one client that stops reading cannot hold
+// publishers back indefinitely
+void ipc_evict_stalled(IpcClient clients[]) {
+    time_t now = time(NULL);
+
+    for (int i = 0; i < MAX_IPC_CLIENTS; i++) {
+        if (clients[i].fd >= 0 && clients[i].stalled_since != 0 &&
+            now - clients[i].stalled_since >= IPC_STALL_TIMEOUT) {
+            printf("\n[IPC] Client %d evicted: deliveries not read for %ds\n",
+                   i, IPC_STALL_TIMEOUT);
+            ipc_close_client(&clients[i]);
+        }
+    }
+}
+
+// Originate a gossip message from this node. The sequence number keeps
+// repeated payloads distinct, so the seen-message cache never drops them.
+void publish_message(NodeContext *ctx, const char *text) {
+    char formattedMessage[MAX_BUFFER_SIZE];
+    snprintf(formattedMessage, MAX_BUFFER_SIZE, "%s#%u: %.900s",
+             ctx->self->id, ctx->next_seq++, text);
+
+    printf("\n[GOSSIP SENT] %s\n", formattedMessage);
+
+    // Add to cached messages to avoid receiving our own message back
+    if (!is_duplicate_message(formattedMessage, ctx->seen)) {
+        ipc_deliver(ctx->clients, formattedMessage);
+    }
+
+    send_to_random_peers(ctx->srvsock, ctx->view, formattedMessage, 0);
+}
+
+// Handle one local request: "PUB\n<msg>\n<msg>...", "SUB", "VIEW", "CYCLE"
+// or "BYE". client is the IPC slot, or -1 for requests typed on stdin.
+// Returns 1 when the node should shut down.
+int handle_request(NodeContext *ctx, char *req, int client) {
+    IpcClient *ipc = (client >= 0) ? &ctx->clients[client] : NULL;
+    char reply[MAX_BUFFER_SIZE];
+
+    if (strncmp(req, "PUB\n", 4) == 0) {
+        // One message per line; lines past IPC_MAX_BATCH are not published
+        int published = 0;
+        char *line = req + 4;
+
+        while (line && *line && published < IPC_MAX_BATCH) {
+            char *next = strchr(line, '\n');
+            if (next) *next++ = '\0';
+
+            if (*line) {
+                publish_message(ctx, line);
+                published++;
+            }
+            line = next;
+        }
+
+        if (ipc) {
+            snprintf(reply, sizeof(reply), "OK %d", published);
+            ipc_reply(ipc, reply);
+        }
+        return 0;
+    }
+
+    req[strcspn(req, "\r\n")] = 0;
+
+    if (strcmp(req, "BYE") == 0) {
+        printf("Exiting...\n");
+        return 1;
+    } else if (strcmp(req, "SUB") == 0 && ipc) {
+        ipc->subscribed = 1;
+        ipc_reply(ipc, "OK");
+    } else if (strcmp(req, "VIEW") == 0) {
+        // Print current view
+        View *view = ctx->view;
+        int len = snprintf(reply, sizeof(reply), "\n[VIEW] Current view (%d nodes):\n", view->count);
+        for (int i = 0; i < view->count; i++) {
+            len += snprintf(reply + len, sizeof(reply) - len,
+                            "  %d. %s (%s:%d) [age: %lds]\n",
+                            i+1,
+                            view->descriptors[i].id,
+                            view->descriptors[i].ipaddr,
+                            view->descriptors[i].port,
+                            time(NULL) - view->descriptors[i].timestamp);
+        }
+
+        if (ipc) {
+            ipc_reply(ipc, reply);
+        } else {
+            printf("%s", reply);
         }
-        strcpy(cached_msgs[MAX_CACHED_MSGS-1], msg);
+    } else if (strcmp(req, "CYCLE") == 0) {
+        // Force a Cyclon cycle
+        *ctx->last_cycle_time = 0;  // This will trigger a cycle on next iteration
+        if (ipc) ipc_reply(ipc, "OK");
+    } else if (ipc) {
+        ipc_reply(ipc, "ERROR unknown request");
     }
 
     return 0;
 }
 
+// Handle terminal input. stdin is a thin client of the request handler:
+// VIEW, CYCLE and BYE pass through and other lines are batched into PUB.
+// Only complete lines are handled unless final is set (stdin closed) or one
+// line fills the whole buffer. Lines are held back while a subscriber is
+// backed up.
+// Returns the number of unhandled bytes, which are moved to the front.
+int handle_stdin_input(NodeContext *ctx, char *input, int len, int final, int *running) {
+    char batch[2 * MAX_BUFFER_SIZE];
+    int batched = 0;
+    int batchlen = sprintf(batch, "PUB\n");
+    int pos = 0;
+
+    input[len] = '\0';
+
+    while (pos < len && *running) {
+        char *line = input + pos;
+        char *end = memchr(line, '\n', len - pos);
+
+        if (!end) {
+            // Partial line: wait for the rest of it, unless it alone fills
+            // the whole buffer
+            if (!final && (pos > 0 || len < MAX_BUFFER_SIZE - 1)) break;
+            end = input + len;
+        }
+
+        int linelen = end - line;
+
+        // Raw input may contain NUL bytes, which no message can carry
+        if (memchr(line, '\0', linelen)) {
+            printf("→ Ignoring input line containing a NUL byte\n");
+            pos = (end < input + len) ? pos + linelen + 1 : len;
+            continue;
+        }
+
+        int is_command = (linelen == 4 && strncmp(line, "VIEW", 4) == 0) ||
+                         (linelen == 5 && strncmp(line, "CYCLE", 5) == 0) ||
+                         (linelen == 3 && strncmp(line, "BYE", 3) == 0);
+
+        if (!is_command && linelen > 0) {
+            // A batch never exceeds IPC_MAX_BATCH, so room is checked per batch
+            if (batched == 0 && !ipc_subscribers_have_room(ctx->clients)) break;
+
+            batchlen += sprintf(batch + batchlen, "%.*s\n", linelen, line);
+            batched++;
+        }
+
+        pos = (end < input + len) ? pos + linelen + 1 : len;
+
+        // Publish pending messages before a command or when the batch is full
+        if (batched > 0 && (is_command || batched == IPC_MAX_BATCH)) {
+            handle_request(ctx, batch, -1);
+            batched = 0;
+            batchlen = sprintf(batch, "PUB\n");
+        }
+
+        if (is_command) {
+            char cmd[8];
+            snprintf(cmd, sizeof(cmd), "%.*s", linelen, line);
+            if (handle_request(ctx, cmd, -1)) *running = 0;
+        }
+    }
+
+    if (batched > 0) {
+        handle_request(ctx, batch, -1);
+    }
+
+    memmove(input, input + pos, len - pos);
+    return len - pos;
+}
+
 int main(int argc, char *argv[]) {
     if (argc < 2) {
-        fprintf(stderr, "Usage: %s <port>\n", argv[0]);
+        fprintf(stderr, "Usage: %s <port> [ipc_socket_path]\n", argv[0]);
         exit(EXIT_FAILURE);
     }
 
-    int srvsock, portno, maxfd, result;
+    int srvsock, ipcsock, portno, maxfd, result;
     struct sockaddr_in serveraddr, clientaddr;
     socklen_t len = sizeof(clientaddr);
-    fd_set readset, tempset;
+    fd_set readset, tempset, writeset;
     char buf[MAX_BUFFER_SIZE];
-    char cached_msgs[MAX_CACHED_MSGS][MAX_BUFFER_SIZE];
-    int msg_count = 0;
+    static SeenCache seen_msgs;
+    static char ipcbuf[MAX_IPC_PACKET];
+    static char stdinbuf[MAX_BUFFER_SIZE];
+    int stdinlen = 0;
+    int stdin_open = 1;
+    static IpcClient ipcClients[MAX_IPC_CLIENTS];
 
     // Remember the last gossip partner to avoid repeat exchanges
     NodeDescriptor last_partner;
@@ -246,6 +684,24 @@ int main(int argc, char *argv[]) {
         error("ERROR on binding");
     }
 
+    // A larger receive buffer absorbs gossip bursts between select() wakeups;
+    // the kernel caps it at net.core.rmem_max
+    int rcvbuf = NET_RECV_BUFFER;
+    setsockopt(srvsock, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+    // Open the local IPC endpoint, by default /tmp/cyclon-<port>.sock
+    char ipcPath[108];
+    if (argc > 2) {
+        snprintf(ipcPath, sizeof(ipcPath), "%s", argv[2]);
+    } else {
+        snprintf(ipcPath, sizeof(ipcPath), "/tmp/cyclon-%d.sock", portno);
+    }
+    ipcsock = open_ipc_socket(ipcPath);
+
+    for (int i = 0; i < MAX_IPC_CLIENTS; i++) {
+        ipcClients[i].fd = -1;
+    }
+
     // Initialize my view with RANDOM subset of nodes (proper bootstrapping)
     View myView;
     myView.count = 0;
@@ -284,25 +740,66 @@ int main(int argc, char *argv[]) {
                myView.descriptors[i].ipaddr,
                myView.descriptors[i].port);
     }
+    printf("Local IPC endpoint: %s\n", ipcPath);
 
     // Set up for select()
     FD_ZERO(&readset);
     FD_SET(srvsock, &readset);
-    FD_SET(STDIN_FILENO, &readset);
+    FD_SET(ipcsock, &readset);
     maxfd = (srvsock > STDIN_FILENO) ? srvsock : STDIN_FILENO;
+    maxfd = (ipcsock > maxfd) ? ipcsock : maxfd;
 
     // Set up cyclic timer for Cyclon protocol (every 10 seconds)
     time_t last_cycle_time = time(NULL);
     int cycle_interval = 10; // seconds
 
-    while (1) {
+    NodeContext ctx;
+    ctx.srvsock = srvsock;
+    ctx.self = &myDescriptor;
+    ctx.view = &myView;
+    ctx.seen = &seen_msgs;
+    ctx.last_cycle_time = &last_cycle_time;
+    ctx.clients = ipcClients;
+    ctx.next_seq = (unsigned int)rand();  // Avoid reusing a previous run's numbers
+
+    int running = 1;
+    while (running) {
         // Set timeout for select to handle cyclic behavior
         struct timeval tv;
         tv.tv_sec = 1;  // Check every second
         tv.tv_usec = 0;
 
+        // Add IPC clients: a client whose next request is a held-back PUB is
+        // only read again once subscribers have room, a client with a full
+        // reply queue once it reads its replies, and clients are watched for
+        // writability while replies or deliveries are queued
+        ipc_evict_stalled(ipcClients);
+
         tempset = readset;
-        result = select(maxfd + 1, &tempset, NULL, NULL, &tv);
+        FD_ZERO(&writeset);
+        int loopmaxfd = maxfd;
+        int accepting = ipc_subscribers_have_room(ipcClients);
+
+        // Terminal input is a publisher too and obeys the same backpressure
+        if (stdin_open && accepting && stdinlen < MAX_BUFFER_SIZE - 1) {
+            FD_SET(STDIN_FILENO, &tempset);
+        }
+
+        for (int i = 0; i < MAX_IPC_CLIENTS; i++) {
+            IpcClient *client = &ipcClients[i];
+            if (client->fd < 0) continue;
+
+            if (accepting) client->held = 0;
+            if (!client->held && client->reply_count < IPC_REPLY_QUEUE) {
+                FD_SET(client->fd, &tempset);
+            }
+            if (client->reply_count > 0 || client->count > 0 || client->dropped > 0) {
+                FD_SET(client->fd, &writeset);
+            }
+            if (client->fd > loopmaxfd) loopmaxfd = client->fd;
+        }
+
+        result = select(loopmaxfd + 1, &tempset, &writeset, NULL, &tv);
 
         if (result < 0) error("ERROR on select");
 
@@ -376,10 +873,14 @@ int main(int argc, char *argv[]) {
             }
         }
 
-        // Handle incoming messages
-        if (result > 0 && FD_ISSET(srvsock, &tempset)) {
+        // Handle incoming messages, draining several datagrams per wakeup
+        for (int r = 0; result > 0 && FD_ISSET(srvsock, &tempset) && r < NET_READS_PER_WAKEUP; r++) {
             memset(buf, 0, MAX_BUFFER_SIZE);
-            recvfrom(srvsock, buf, MAX_BUFFER_SIZE, 0, (struct sockaddr *)&clientaddr, &len);
+            len = sizeof(clientaddr);
+            if (recvfrom(srvsock, buf, MAX_BUFFER_SIZE - 1, MSG_DONTWAIT,
+                         (struct sockaddr *)&clientaddr, &len) < 0) {
+                break;
+            }
 
             // Parse message
             if (strncmp(buf, "CYCLON_PUSH:", 12) == 0) {
@@ -545,128 +1046,101 @@ int main(int argc, char *argv[]) {
                 printf("\n[GOSSIP RECEIVED] %s\n", buf);
 
                 // Check if we've seen this message before
-                if (!is_duplicate_message(buf, cached_msgs, &msg_count)) {
-                    // Forward to random peers
-                    if (myView.count > 0) {
-                        // Shuffle view indices for random selection
-                        int indices[VIEW_LENGTH];
-                        for (int i = 0; i < myView.count; i++) {
-                            indices[i] = i;
-                        }
+                if (!is_duplicate_message(buf, &seen_msgs)) {
+                    ipc_deliver(ipcClients, buf);
 
-                        // Fisher-Yates shuffle
-                        for (int i = myView.count - 1; i > 0; i--) {
-                            int j = rand() % (i + 1);
-                            int temp = indices[i];
-                            indices[i] = indices[j];
-                            indices[j] = temp;
-                        }
-
-                        // Select up to FORWARD_COUNT peers
-                        int forward_to = (myView.count < FORWARD_COUNT) ? myView.count : FORWARD_COUNT;
-
-                        struct sockaddr_in peeraddr;
-                        printf("→ Forwarding to peers:\n");
-
-                        for (int i = 0; i < forward_to; i++) {
-                            memset(&peeraddr, 0, sizeof(peeraddr));
-                            peeraddr.sin_family = AF_INET;
-                            peeraddr.sin_port = htons(myView.descriptors[indices[i]].port);
-                            inet_pton(AF_INET, myView.descriptors[indices[i]].ipaddr, &peeraddr.sin_addr);
-
-                            printf("   → Peer: %s (%s:%d)\n",
-                                myView.descriptors[indices[i]].id,
-                                myView.descriptors[indices[i]].ipaddr,
-                                myView.descriptors[indices[i]].port);
-
-                            sendto(srvsock, buf, strlen(buf), 0,
-                                (struct sockaddr *)&peeraddr, sizeof(peeraddr));
-                        }
-                    } else {
-                        printf("→ No peers in view to forward message to\n");
-                    }
+                    // Forward to random peers
+                    send_to_random_peers(srvsock, &myView, buf, 1);
                 } else {
                     printf("→ Duplicate message, not forwarding\n");
                 }
             }
         }
 
-        // Handle user input
+        // Handle user input, keeping any partial line for the next read
         if (result > 0 && FD_ISSET(STDIN_FILENO, &tempset)) {
-            memset(buf, 0, MAX_BUFFER_SIZE);
-            read(STDIN_FILENO, buf, MAX_BUFFER_SIZE);
-            buf[strcspn(buf, "\n")] = 0;
+            ssize_t n = read(STDIN_FILENO, stdinbuf + stdinlen, MAX_BUFFER_SIZE - 1 - stdinlen);
 
-            if (strcmp(buf, "BYE") == 0) {
-                printf("Exiting...\n");
-                break;
-            } else if (strcmp(buf, "VIEW") == 0) {
-                // Print current view
-                printf("\n[VIEW] Current view (%d nodes):\n", myView.count);
-                for (int i = 0; i < myView.count; i++) {
-                    printf("  %d. %s (%s:%d) [age: %lds]\n",
-                           i+1,
-                           myView.descriptors[i].id,
-                           myView.descriptors[i].ipaddr,
-                           myView.descriptors[i].port,
-                           time(NULL) - myView.descriptors[i].timestamp);
-                }
-            } else if (strcmp(buf, "CYCLE") == 0) {
-                // Force a Cyclon cycle
-                last_cycle_time = 0;  // This will trigger a cycle on next iteration
+            if (n > 0) {
+                stdinlen += n;
             } else {
-                // Regular gossip message
-                char formattedMessage[MAX_BUFFER_SIZE];
-                snprintf(formattedMessage, MAX_BUFFER_SIZE, "%s: %.900s", myDescriptor.id, buf);
+                // stdin closed; keep serving gossip and IPC clients
+                stdin_open = 0;
+            }
+        }
 
-                printf("\n[GOSSIP SENT] %s\n", formattedMessage);
+        if (stdinlen > 0 && running) {
+            stdinlen = handle_stdin_input(&ctx, stdinbuf, stdinlen, !stdin_open, &running);
+        }
 
-                // Add to cached messages to avoid receiving our own message back
-                is_duplicate_message(formattedMessage, cached_msgs, &msg_count);
+        // Flush queued deliveries to subscribers that can take them
+        for (int i = 0; i < MAX_IPC_CLIENTS; i++) {
+            IpcClient *client = &ipcClients[i];
+            if (result > 0 && client->fd >= 0 && FD_ISSET(client->fd, &writeset)) {
+                if (ipc_flush_client(client) < 0) {
+                    printf("\n[IPC] Client %d disconnected\n", i);
+                    ipc_close_client(client);
+                }
+            }
+        }
 
-                // Select random nodes from view to send to
-                if (myView.count > 0) {
-                    // Shuffle view indices for random selection
-                    int indices[VIEW_LENGTH];
-                    for (int i = 0; i < myView.count; i++) {
-                        indices[i] = i;
-                    }
+        // Handle new local clients
+        if (result > 0 && FD_ISSET(ipcsock, &tempset)) {
+            ipc_accept_client(ipcsock, ipcClients);
+        }
 
-                    // Fisher-Yates shuffle
-                    for (int i = myView.count - 1; i > 0; i--) {
-                        int j = rand() % (i + 1);
-                        int temp = indices[i];
-                        indices[i] = indices[j];
-                        indices[j] = temp;
+        // Handle local requests, draining several per client per wakeup
+        for (int i = 0; i < MAX_IPC_CLIENTS && running; i++) {
+            IpcClient *client = &ipcClients[i];
+            if (result <= 0 || client->fd < 0 || !FD_ISSET(client->fd, &tempset)) continue;
+
+            for (int r = 0; r < IPC_READS_PER_WAKEUP && running; r++) {
+                // Every request may need a reply; wait until one can be queued
+                if (client->reply_count == IPC_REPLY_QUEUE) break;
+
+                // Hold back a PUB while a subscriber is backed up; other
+                // requests are always served
+                if (!ipc_subscribers_have_room(ipcClients)) {
+                    char hdr[4];
+                    ssize_t peeked = recv(client->fd, hdr, sizeof(hdr), MSG_PEEK | MSG_DONTWAIT);
+                    if (peeked == sizeof(hdr) && strncmp(hdr, "PUB\n", 4) == 0) {
+                        client->held = 1;
+                        break;
                     }
+                }
 
-                    // Select up to FORWARD_COUNT peers
-                    int send_to = (myView.count < FORWARD_COUNT) ? myView.count : FORWARD_COUNT;
-
-                    struct sockaddr_in peeraddr;
-                    printf("→ Sending to peers:\n");
-
-                    for (int i = 0; i < send_to; i++) {
-                        memset(&peeraddr, 0, sizeof(peeraddr));
-                        peeraddr.sin_family = AF_INET;
-                        peeraddr.sin_port = htons(myView.descriptors[indices[i]].port);
-                        inet_pton(AF_INET, myView.descriptors[indices[i]].ipaddr, &peeraddr.sin_addr);
+                // MSG_TRUNC returns the full packet length even when it is cut off
+                ssize_t n = recv(client->fd, ipcbuf, MAX_IPC_PACKET - 1, MSG_DONTWAIT | MSG_TRUNC);
+                if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+                if (n <= 0) {
+                    printf("\n[IPC] Client %d disconnected\n", i);
+                    ipc_close_client(client);
+                    break;
+                }
 
-                        printf("   → Peer: %s (%s:%d)\n",
-                            myView.descriptors[indices[i]].id,
-                            myView.descriptors[indices[i]].ipaddr,
-                            myView.descriptors[indices[i]].port);
+                // Never act on part of a request
+                if (n > MAX_IPC_PACKET - 1) {
+                    ipc_reply(client, "ERROR packet too large");
+                    continue;
+                }
+                if (memchr(ipcbuf, '\0', n)) {
+                    ipc_reply(client, "ERROR packet contains NUL");
+                    continue;
+                }
 
-                        sendto(srvsock, formattedMessage, strlen(formattedMessage), 0,
-                            (struct sockaddr *)&peeraddr, sizeof(peeraddr));
-                    }
-                } else {
-                    printf("→ No peers in view to send message to\n");
+                ipcbuf[n] = '\0';
+                if (handle_request(&ctx, ipcbuf, i)) {
+                    running = 0;
                 }
             }
         }
     }
 
+    for (int i = 0; i < MAX_IPC_CLIENTS; i++) {
+        if (ipcClients[i].fd >= 0) ipc_close_client(&ipcClients[i]);
+    }
+    close(ipcsock);
+    unlink(ipcPath);
     close(srvsock);
     return 0;
 }
\ No newline at end of file